@@ -1,9 +1,27 @@
 ﻿
 
+#define _CRT_SECURE_NO_WARNINGS // fopen/sscanf under /sdl
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>              // wglGetProcAddress for the replay framebuffer
+#endif
 #include <glut.h>
+#ifndef _WIN32
+#include <GL/glx.h>
+#endif
 #include <math.h>
 #include <SOIL2.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
 
 
 #ifndef M_PI
@@ -62,6 +80,97 @@ float angle = 0.0f;
 float camDistance = 1150.0f;
 float camHeight = 480.0f;
 
+// ---------------- Frame memory ----------------
+// Every heap allocation bumps this counter; beginFrame()/endFrame() turn it into
+// a per-frame count so steady-state frames can be checked to allocate nothing.
+// MSVC debug builds hook the CRT heap, which also sees malloc (GLU quadrics
+// included, when they share this CRT). Other builds only count operator new.
+std::atomic<unsigned> g_heapAllocCount(0);
+unsigned g_lastFrameAllocs = 0;     // heap allocations during the last frame
+unsigned g_steadyAllocFrames = 0;   // frames past warm-up that allocated
+unsigned g_frameNumber = 0;
+const unsigned FRAME_WARMUP = 2;    // lazily-initialized objects are created in these
+unsigned g_steadyStateFrom = FRAME_WARMUP; // frames after this one must not allocate
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+static int crtAllocHook(int type, void*, size_t, int blockType, long, const unsigned char*, int) {
+    // _CRT_BLOCK is the CRT's own bookkeeping; the hook must not recurse into it
+    if (blockType != _CRT_BLOCK && (type == _HOOK_ALLOC || type == _HOOK_REALLOC))
+        g_heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    return 1; // let the allocation proceed
+}
+static const _CRT_ALLOC_HOOK g_prevAllocHook = _CrtSetAllocHook(crtAllocHook);
+#else
+void* operator new(size_t size) {
+    g_heapAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+const size_t FRAME_ARENA_BYTES = 256 * 1024;
+
+// Linear allocator reset once per frame; nothing allocated from it is freed individually
+class FrameArena {
+public:
+    FrameArena() : base(new unsigned char[FRAME_ARENA_BYTES]), capacity(FRAME_ARENA_BYTES), used(0) {}
+    ~FrameArena() { delete[] base; }
+
+    // Returns nullptr when the arena is exhausted; callers fall back to an unsorted/direct path
+    void* alloc(size_t bytes, size_t align = 16) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + bytes > capacity) return nullptr;
+        used = start + bytes;
+        return base + start;
+    }
+    template <typename T> T* allocArray(size_t count) {
+        return static_cast<T*>(alloc(count * sizeof(T), alignof(T)));
+    }
+    void reset() { used = 0; }
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+private:
+    unsigned char* base;
+    size_t capacity;
+    size_t used;
+};
+
+// Double-buffered so data built for frame N stays valid while frame N+1 is being built
+FrameArena g_frameArenas[2];
+
+inline FrameArena& frameArena() { return g_frameArenas[g_frameNumber & 1]; }
+
+unsigned g_frameAllocBase = 0;
+
+void beginFrame() {
+    ++g_frameNumber;
+    frameArena().reset();
+    g_frameAllocBase = g_heapAllocCount.load(std::memory_order_relaxed);
+}
+
+// Past warm-up the loop must not allocate; offending frames are counted and fail a replay run
+void endFrame() {
+    g_lastFrameAllocs = g_heapAllocCount.load(std::memory_order_relaxed) - g_frameAllocBase;
+    if (g_frameNumber > g_steadyStateFrom && g_lastFrameAllocs) {
+        if (!g_steadyAllocFrames)
+            printf("Frame %u made %u heap allocations\n", g_frameNumber, g_lastFrameAllocs);
+        ++g_steadyAllocFrames;
+    }
+}
+
+// Registered with atexit so interactive and recording runs report every offending frame
+void reportFrameAllocs() {
+    unsigned steadyFrames = g_frameNumber > g_steadyStateFrom ? g_frameNumber - g_steadyStateFrom : 0;
+    printf("Steady-state frames with heap allocations: %u of %u\n", g_steadyAllocFrames, steadyFrames);
+}
+
 // ---------------- Helpers ----------------
 inline bool inRect(float x, float z, float cx, float cz, float w, float h, float margin = 0.0f) {
     return (x >= cx - w * 0.5f - margin) && (x <= cx + w * 0.5f + margin) &&
@@ -177,6 +286,32 @@ static inline float mesaHeight(float dx, float dz, float baseR, float topR, floa
 }
 
 // ---------------- Terrain (grassy base + mesas) ----------------
+const float TERRAIN_A_MARGIN = 2.0f * APRON_EDGE + 6.0f; // apron safe margin
+const float TERRAIN_R_MARGIN = 4.0f;
+
+// Height above BASE_Y at world (x, z); shared by the full-precision and packed paths
+static float terrainHeight(float x, float z) {
+    bool insideApron = inRect(x, z, 0.0f, 0.0f, APRON_W, APRON_H, TERRAIN_A_MARGIN);
+    bool insideRoad = inRect(x, z, (ROAD_X0 + ROAD_X1) * 0.5f, ROAD_Z,
+        (ROAD_X1 - ROAD_X0), ROAD_W, TERRAIN_R_MARGIN);
+
+    // Base undulations
+    float y = 6.0f * sinf(x * 0.0045f) + 5.0f * cosf(z * 0.0050f);
+    y += 2.2f * sinf((x + z) * 0.0032f);
+
+    // Mesas
+    for (int k = 0; k < HILL_COUNT; ++k) {
+        y += mesaHeight(x - HILLS[k].x, z - HILLS[k].z,
+            HILLS[k].baseR, HILLS[k].topR, HILLS[k].height);
+    }
+
+    // Flatten for apron/road
+    if (insideApron || insideRoad) y = TERRAIN_MIN_HEIGHT;
+    if (y < TERRAIN_MIN_HEIGHT) y = TERRAIN_MIN_HEIGHT;
+    return y;
+}
+
+// Full-precision reference path (immediate mode, recomputed every frame)
 void drawTerrain() {
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, grassTexture);
@@ -185,9 +320,6 @@ void drawTerrain() {
     const float d = (float)TERRAIN_SIZE / TERRAIN_GRID_RES;
     const float offset = TERRAIN_SIZE * 0.5f;
 
-    const float A_MARGIN = 2.0f * APRON_EDGE + 6.0f; // apron safe margin
-    const float R_MARGIN = 4.0f;
-
     for (int i = 0; i < TERRAIN_GRID_RES; ++i) {
         glBegin(GL_TRIANGLE_STRIP);
         for (int j = 0; j <= TERRAIN_GRID_RES; ++j) {
@@ -197,35 +329,8 @@ void drawTerrain() {
             float x2 = (i + 1) * d - offset;
             float z2 = j * d - offset;
 
-            bool insideApron1 = inRect(x1, z1, 0.0f, 0.0f, APRON_W, APRON_H, A_MARGIN);
-            bool insideRoad1 = inRect(x1, z1, (ROAD_X0 + ROAD_X1) * 0.5f, ROAD_Z,
-                (ROAD_X1 - ROAD_X0), ROAD_W, R_MARGIN);
-
-            bool insideApron2 = inRect(x2, z2, 0.0f, 0.0f, APRON_W, APRON_H, A_MARGIN);
-            bool insideRoad2 = inRect(x2, z2, (ROAD_X0 + ROAD_X1) * 0.5f, ROAD_Z,
-                (ROAD_X1 - ROAD_X0), ROAD_W, R_MARGIN);
-
-            // Base undulations
-            float y1 = 6.0f * sinf(x1 * 0.0045f) + 5.0f * cosf(z1 * 0.0050f);
-            y1 += 2.2f * sinf((x1 + z1) * 0.0032f);
-
-            float y2 = 6.0f * sinf(x2 * 0.0045f) + 5.0f * cosf(z2 * 0.0050f);
-            y2 += 2.2f * sinf((x2 + z2) * 0.0032f);
-
-            // Mesas
-            for (int k = 0; k < HILL_COUNT; ++k) {
-                y1 += mesaHeight(x1 - HILLS[k].x, z1 - HILLS[k].z,
-                    HILLS[k].baseR, HILLS[k].topR, HILLS[k].height);
-                y2 += mesaHeight(x2 - HILLS[k].x, z2 - HILLS[k].z,
-                    HILLS[k].baseR, HILLS[k].topR, HILLS[k].height);
-            }
-
-            // Flatten for apron/road
-            if (insideApron1 || insideRoad1) y1 = TERRAIN_MIN_HEIGHT;
-            if (insideApron2 || insideRoad2) y2 = TERRAIN_MIN_HEIGHT;
-
-            if (y1 < TERRAIN_MIN_HEIGHT) y1 = TERRAIN_MIN_HEIGHT;
-            if (y2 < TERRAIN_MIN_HEIGHT) y2 = TERRAIN_MIN_HEIGHT;
+            float y1 = terrainHeight(x1, z1);
+            float y2 = terrainHeight(x2, z2);
 
             float u1 = x1 * 0.0025f, v1 = z1 * 0.0025f;
             float u2 = x2 * 0.0025f, v2 = z2 * 0.0025f;
@@ -242,6 +347,260 @@ void drawTerrain() {
     glDisable(GL_TEXTURE_2D);
 }
 
+// ---------------- Packed static meshes ----------------
+// Terrain and hangar geometry is built once into compact vertex arrays and
+// dequantized by the modelview/texture matrices, so the CPU no longer
+// re-evaluates the heightfield or streams 32-byte vertices every frame.
+// Key 'p' switches back to the full-precision path for comparison.
+bool g_usePackedMeshes = true;
+
+// Cells per terrain tile; (TILE + 1)^2 vertices must fit 16-bit indices
+const int TERRAIN_TILE_CELLS = 120;
+
+// Grid index (i, j) in x/z, 16-bit quantized height in y
+struct TerrainVertexPacked { GLshort i, h, j, pad; };   // 8 bytes
+
+struct TerrainTile {
+    float cx, cz;                        // world-space center, for draw ordering
+    std::vector<TerrainVertexPacked> verts;
+    std::vector<GLushort> indices;       // one stitched triangle strip
+};
+
+std::vector<TerrainTile> g_terrainTiles;
+float g_terrainHeightMid = 0.0f;         // dequantize: y = mid + h * step
+float g_terrainHeightStep = 1.0f;
+
+// Quantized position, byte normal, integer UV (scaled by the texture matrix)
+struct StaticVertexPacked {
+    GLshort pos[4];
+    GLbyte  n[4];
+    GLshort uv[2];
+};                                        // 16 bytes
+
+struct StaticMeshPacked {
+    std::vector<StaticVertexPacked> verts;
+    std::vector<GLushort> indices;
+    GLenum mode;
+};
+
+StaticMeshPacked g_shellMesh;
+StaticMeshPacked g_endWallMesh;
+const float HANGAR_POS_STEP = (LENGTH * 0.5f) / 32767.0f; // covers RADIUS and LENGTH / 2
+
+static inline GLshort quantizeS16(float v, float step) {
+    float q = v / step;
+    q = q < -32767.0f ? -32767.0f : (q > 32767.0f ? 32767.0f : q);
+    return (GLshort)(q < 0.0f ? q - 0.5f : q + 0.5f);
+}
+
+static inline GLbyte quantizeS8(float v) {
+    return (GLbyte)(v < 0.0f ? v * 127.0f - 0.5f : v * 127.0f + 0.5f);
+}
+
+// Append rows of a (rows+1) x (cols+1) row-major grid as one strip, stitched with degenerates
+static void appendGridStrip(std::vector<GLushort>& out, int rows, int cols) {
+    for (int a = 0; a < rows; ++a) {
+        if (a > 0) {
+            out.push_back(out.back());
+            out.push_back((GLushort)(a * (cols + 1)));
+        }
+        for (int b = 0; b <= cols; ++b) {
+            out.push_back((GLushort)(a * (cols + 1) + b));
+            out.push_back((GLushort)((a + 1) * (cols + 1) + b));
+        }
+    }
+}
+
+void buildTerrainMesh() {
+    const float d = (float)TERRAIN_SIZE / TERRAIN_GRID_RES;
+    const float offset = TERRAIN_SIZE * 0.5f;
+    const int N = TERRAIN_GRID_RES + 1;
+
+    std::vector<float> heights(N * N);
+    float hMin = 1e30f, hMax = -1e30f;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            float y = terrainHeight(i * d - offset, j * d - offset);
+            heights[i * N + j] = y;
+            if (y < hMin) hMin = y;
+            if (y > hMax) hMax = y;
+        }
+    }
+    g_terrainHeightMid = 0.5f * (hMin + hMax);
+    g_terrainHeightStep = (hMax > hMin) ? (hMax - hMin) / 65534.0f : 1.0f;
+
+    float maxErr = 0.0f;
+    size_t vertBytes = 0, indexBytes = 0;
+    g_terrainTiles.clear();
+    for (int ti = 0; ti < TERRAIN_GRID_RES; ti += TERRAIN_TILE_CELLS) {
+        for (int tj = 0; tj < TERRAIN_GRID_RES; tj += TERRAIN_TILE_CELLS) {
+            int rows = TERRAIN_GRID_RES - ti < TERRAIN_TILE_CELLS ? TERRAIN_GRID_RES - ti : TERRAIN_TILE_CELLS;
+            int cols = TERRAIN_GRID_RES - tj < TERRAIN_TILE_CELLS ? TERRAIN_GRID_RES - tj : TERRAIN_TILE_CELLS;
+
+            TerrainTile tile;
+            tile.cx = (ti + rows * 0.5f) * d - offset;
+            tile.cz = (tj + cols * 0.5f) * d - offset;
+            tile.verts.reserve((rows + 1) * (cols + 1));
+            for (int a = 0; a <= rows; ++a) {
+                for (int b = 0; b <= cols; ++b) {
+                    float y = heights[(ti + a) * N + (tj + b)];
+                    TerrainVertexPacked v;
+                    v.i = (GLshort)(ti + a);
+                    v.j = (GLshort)(tj + b);
+                    v.h = quantizeS16(y - g_terrainHeightMid, g_terrainHeightStep);
+                    v.pad = 0;
+                    tile.verts.push_back(v);
+
+                    float err = fabsf(g_terrainHeightMid + v.h * g_terrainHeightStep - y);
+                    if (err > maxErr) maxErr = err;
+                }
+            }
+            appendGridStrip(tile.indices, rows, cols);
+
+            vertBytes += tile.verts.size() * sizeof(TerrainVertexPacked);
+            indexBytes += tile.indices.size() * sizeof(GLushort);
+            g_terrainTiles.push_back(tile);
+        }
+    }
+
+    // Full-precision vertex: 3 pos + 3 normal + 2 uv floats
+    const size_t fullVertex = 8 * sizeof(float);
+    size_t fullCached = (size_t)N * N * fullVertex;
+    size_t fullStreamed = (size_t)TERRAIN_GRID_RES * N * 2 * fullVertex;
+    printf("Terrain %dx%d: full-precision %.2f MB cached / %.2f MB streamed per frame\n",
+        TERRAIN_GRID_RES, TERRAIN_GRID_RES, fullCached / 1048576.0, fullStreamed / 1048576.0);
+    // Client-side arrays are still sent every frame, tile-border duplicates included
+    printf("Terrain packed: %d tiles, %.2f MB vertices + %.2f MB indices = %.2f MB streamed per frame, max height error %.4f\n",
+        (int)g_terrainTiles.size(), vertBytes / 1048576.0, indexBytes / 1048576.0,
+        (vertBytes + indexBytes) / 1048576.0, maxErr);
+}
+
+void buildHangarMeshes() {
+    float dT = (float)M_PI / SEG_ARC;
+    float z0 = -LENGTH * 0.5f;
+    float dZ = LENGTH / SEG_LEN;
+
+    // Shell: (SEG_ARC + 1) x (SEG_LEN + 1) grid, radial normals, uv = (i, j)
+    g_shellMesh.verts.clear();
+    g_shellMesh.indices.clear();
+    g_shellMesh.mode = GL_TRIANGLE_STRIP;
+    for (int i = 0; i <= SEG_ARC; ++i) {
+        float t = i * dT;
+        float x, y;
+        archPoint(t, x, y);
+        for (int j = 0; j <= SEG_LEN; ++j) {
+            StaticVertexPacked v;
+            v.pos[0] = quantizeS16(x, HANGAR_POS_STEP);
+            v.pos[1] = quantizeS16(y, HANGAR_POS_STEP);
+            v.pos[2] = quantizeS16(z0 + j * dZ, HANGAR_POS_STEP);
+            v.pos[3] = 0;
+            v.n[0] = quantizeS8(cosf(t)); v.n[1] = quantizeS8(sinf(t)); v.n[2] = 0; v.n[3] = 0;
+            v.uv[0] = (GLshort)i; v.uv[1] = (GLshort)j;
+            g_shellMesh.verts.push_back(v);
+        }
+    }
+    appendGridStrip(g_shellMesh.indices, SEG_ARC, SEG_LEN);
+
+    // End wall at z = 0: ground/arch vertex pairs, one quad per arc segment.
+    // The facing normal is set per wall at draw time.
+    g_endWallMesh.verts.clear();
+    g_endWallMesh.indices.clear();
+    g_endWallMesh.mode = GL_QUADS;
+    for (int i = 0; i <= SEG_ARC; ++i) {
+        float x, y;
+        archPoint(i * dT, x, y);
+        StaticVertexPacked v = {};
+        v.pos[0] = quantizeS16(x, HANGAR_POS_STEP);
+        g_endWallMesh.verts.push_back(v);
+        v.pos[1] = quantizeS16(y, HANGAR_POS_STEP);
+        g_endWallMesh.verts.push_back(v);
+    }
+    for (int i = 0; i < SEG_ARC; ++i) {
+        g_endWallMesh.indices.push_back((GLushort)(2 * i));
+        g_endWallMesh.indices.push_back((GLushort)(2 * i + 1));
+        g_endWallMesh.indices.push_back((GLushort)(2 * i + 3));
+        g_endWallMesh.indices.push_back((GLushort)(2 * i + 2));
+    }
+
+    size_t fullBytes = ((size_t)SEG_ARC * (SEG_LEN + 1) * 2 + (size_t)SEG_ARC * 4 * 2) * 8 * sizeof(float);
+    // The end-wall mesh is drawn twice per frame, once per wall
+    size_t packedBytes = (g_shellMesh.verts.size() + 2 * g_endWallMesh.verts.size()) * sizeof(StaticVertexPacked)
+        + (g_shellMesh.indices.size() + 2 * g_endWallMesh.indices.size()) * sizeof(GLushort);
+    printf("Hangar: full-precision %.1f KB / packed %.1f KB streamed per frame\n",
+        fullBytes / 1024.0, packedBytes / 1024.0);
+}
+
+struct TerrainTileDraw { float dist2; const TerrainTile* tile; };
+
+// Tiles are drawn front to back from a per-frame draw list so near tiles fill depth first
+void drawTerrainPacked(float eyeX, float eyeZ) {
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, grassTexture);
+    glColor3fv(groundTint);
+
+    const float d = (float)TERRAIN_SIZE / TERRAIN_GRID_RES;
+    const float offset = TERRAIN_SIZE * 0.5f;
+
+    // UVs generated from grid index: u = x * 0.0025, v = z * 0.0025 in world units
+    GLfloat sPlane[] = { d * 0.0025f, 0.0f, 0.0f, -offset * 0.0025f };
+    GLfloat tPlane[] = { 0.0f, 0.0f, d * 0.0025f, -offset * 0.0025f };
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGenfv(GL_S, GL_OBJECT_PLANE, sPlane);
+    glTexGenfv(GL_T, GL_OBJECT_PLANE, tPlane);
+    glEnable(GL_TEXTURE_GEN_S);
+    glEnable(GL_TEXTURE_GEN_T);
+
+    // Grid index + quantized height -> world position
+    glPushMatrix();
+    glTranslatef(-offset, BASE_Y + g_terrainHeightMid, -offset);
+    glScalef(d, g_terrainHeightStep, d);
+
+    glNormal3f(0.0f, 1.0f, 0.0f);
+    size_t tileCount = g_terrainTiles.size();
+    TerrainTileDraw* drawList = frameArena().allocArray<TerrainTileDraw>(tileCount);
+    if (drawList) {
+        for (size_t t = 0; t < tileCount; ++t) {
+            float dx = g_terrainTiles[t].cx - eyeX, dz = g_terrainTiles[t].cz - eyeZ;
+            drawList[t].dist2 = dx * dx + dz * dz;
+            drawList[t].tile = &g_terrainTiles[t];
+        }
+        std::sort(drawList, drawList + tileCount,
+            [](const TerrainTileDraw& a, const TerrainTileDraw& b) { return a.dist2 < b.dist2; });
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (size_t t = 0; t < tileCount; ++t) {
+        const TerrainTile& tile = drawList ? *drawList[t].tile : g_terrainTiles[t];
+        glVertexPointer(3, GL_SHORT, sizeof(TerrainVertexPacked), &tile.verts[0].i);
+        glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)tile.indices.size(), GL_UNSIGNED_SHORT, &tile.indices[0]);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopMatrix();
+    glDisable(GL_TEXTURE_GEN_S);
+    glDisable(GL_TEXTURE_GEN_T);
+    glDisable(GL_TEXTURE_2D);
+}
+
+static void drawStaticMeshPacked(const StaticMeshPacked& mesh, bool withNormals, bool withUVs) {
+    const StaticVertexPacked* v = &mesh.verts[0];
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_SHORT, sizeof(StaticVertexPacked), v->pos);
+    if (withNormals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_BYTE, sizeof(StaticVertexPacked), v->n);
+    }
+    if (withUVs) {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(2, GL_SHORT, sizeof(StaticVertexPacked), v->uv);
+    }
+    glDrawElements(mesh.mode, (GLsizei)mesh.indices.size(), GL_UNSIGNED_SHORT, &mesh.indices[0]);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 // ---------------- Concrete apron + road + edges ----------------
 static void drawRectQuad(float cx, float cy, float cz, float w, float h) {
     float hx = w * 0.5f, hz = h * 0.5f;
@@ -269,9 +628,9 @@ void drawApronAndRoad() {
     float rcx = (ROAD_X0 + ROAD_X1) * 0.5f;
     drawRectQuad(rcx, APRON_Y, ROAD_Z, (ROAD_X1 - ROAD_X0), ROAD_W);
 
-    glDisable(GL_POLYGON_OFFSET_FILL);
-
-    // Edge paint (slightly lifted)
+    // Edge paint (slightly lifted). The lift alone is below depth precision at
+    // camera distance, so it also gets a stronger offset than the slabs.
+    glPolygonOffset(-4.0f, -8.0f);
     glColor3fv(edgeColor);
     const float edgeLift = 0.02f;
     drawRectQuad(-APRON_W * 0.5f - APRON_EDGE * 0.5f, APRON_Y + edgeLift, 0.0f,
@@ -283,6 +642,7 @@ void drawApronAndRoad() {
     drawRectQuad(0.0f, APRON_Y + edgeLift, +APRON_H * 0.5f + APRON_EDGE * 0.5f,
         APRON_W + 2.0f * APRON_EDGE, APRON_EDGE);
 
+    glDisable(GL_POLYGON_OFFSET_FILL);
     glEnable(GL_TEXTURE_2D);
 }
 
@@ -321,6 +681,22 @@ void drawShell() {
     glDisable(GL_TEXTURE_2D);
 }
 
+static void drawDoor(float zPos) {
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(-2.0f, -2.0f);
+
+    glColor3fv(doorColor);
+    glBegin(GL_QUADS);
+    glNormal3f(0, 0, (zPos > 0) ? 1.0f : -1.0f);
+    glVertex3f(-4.0f, 0.0f, zPos);
+    glVertex3f(4.0f, 0.0f, zPos);
+    glVertex3f(4.0f, 7.0f, zPos);
+    glVertex3f(-4.0f, 7.0f, zPos);
+    glEnd();
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+}
+
 void drawEndWall(float zPos, bool withDoor) {
     glColor3fv(wallColor);
     float dT = (float)M_PI / SEG_ARC;
@@ -340,30 +716,59 @@ void drawEndWall(float zPos, bool withDoor) {
         glEnd();
     }
 
-    if (withDoor) {
-        glEnable(GL_POLYGON_OFFSET_FILL);
-        glPolygonOffset(-2.0f, -2.0f);
+    if (withDoor) drawDoor(zPos);
+}
 
-        glColor3fv(doorColor);
-        glBegin(GL_QUADS);
-        glNormal3f(0, 0, (zPos > 0) ? 1.0f : -1.0f);
-        glVertex3f(-4.0f, 0.0f, zPos);
-        glVertex3f(4.0f, 0.0f, zPos);
-        glVertex3f(4.0f, 7.0f, zPos);
-        glVertex3f(-4.0f, 7.0f, zPos);
-        glEnd();
+void drawShellPacked() {
+    glEnable(GL_TEXTURE_2D);
+    glColor3fv(roofColor);
+    glBindTexture(GL_TEXTURE_2D, poleTexture);
 
-        glDisable(GL_POLYGON_OFFSET_FILL);
-    }
+    // uv stored as (arc index, length index)
+    glMatrixMode(GL_TEXTURE);
+    glPushMatrix();
+    glLoadIdentity();
+    glScalef(1.0f / SEG_ARC, 1.0f / SEG_LEN, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+
+    glPushMatrix();
+    glScalef(HANGAR_POS_STEP, HANGAR_POS_STEP, HANGAR_POS_STEP);
+    drawStaticMeshPacked(g_shellMesh, true, true);
+    glPopMatrix();
+
+    glMatrixMode(GL_TEXTURE);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glDisable(GL_TEXTURE_2D);
+}
+
+void drawEndWallPacked(float zPos, bool withDoor) {
+    glColor3fv(wallColor);
+    glNormal3f(0, 0, (zPos > 0) ? 1.0f : -1.0f);
+
+    glPushMatrix();
+    glTranslatef(0.0f, 0.0f, zPos);
+    glScalef(HANGAR_POS_STEP, HANGAR_POS_STEP, HANGAR_POS_STEP);
+    drawStaticMeshPacked(g_endWallMesh, false, false);
+    glPopMatrix();
+
+    if (withDoor) drawDoor(zPos);
 }
 
 void drawHangarOnApron() {
     glPushMatrix();
     glTranslatef(HANGAR_X, APRON_Y, HANGAR_Z);
     glScalef(HANGAR_S, HANGAR_S, HANGAR_S);
-    drawShell();
-    drawEndWall(LENGTH * 0.5f, true);
-    drawEndWall(-LENGTH * 0.5f, false);
+    if (g_usePackedMeshes) {
+        drawShellPacked();
+        drawEndWallPacked(LENGTH * 0.5f, true);
+        drawEndWallPacked(-LENGTH * 0.5f, false);
+    }
+    else {
+        drawShell();
+        drawEndWall(LENGTH * 0.5f, true);
+        drawEndWall(-LENGTH * 0.5f, false);
+    }
     glPopMatrix();
 }
 
@@ -385,11 +790,16 @@ namespace MRAP {
     }
     static void clearEmission() { setEmission(0, 0, 0); }
 
+    // One quadric shared by every cylinder/disk instead of a new/delete per call
+    static GLUquadric* quadric() {
+        static GLUquadric* q = gluNewQuadric();
+        return q;
+    }
+
     static void solidCylinder(float r0, float r1, float h, int slices = 18, int stacks = 1) {
-        GLUquadric* q = gluNewQuadric();
+        GLUquadric* q = quadric();
         gluCylinder(q, r0, r1, h, slices, stacks);
         glPushMatrix(); gluDisk(q, 0.0, r0, slices, 1); glTranslatef(0, 0, h); gluDisk(q, 0.0, r1, slices, 1); glPopMatrix();
-        gluDeleteQuadric(q);
     }
     static void box(float sx, float sy, float sz) { glPushMatrix(); glScalef(sx, sy, sz); glutSolidCube(1.0f); glPopMatrix(); }
 
@@ -409,7 +819,7 @@ namespace MRAP {
     static void grenadeLauncher(float tiltDeg = 28.f) {
         glPushMatrix(); glRotatef(-tiltDeg, 1, 0, 0); C(0.16f, 0.16f, 0.17f);
         solidCylinder(0.11f, 0.11f, 0.9f, 12, 1);
-        glTranslatef(0, 0, 0.9f); GLUquadric* q = gluNewQuadric(); gluDisk(q, 0, 0.11f, 12, 1); gluDeleteQuadric(q);
+        glTranslatef(0, 0, 0.9f); gluDisk(quadric(), 0, 0.11f, 12, 1);
         glPopMatrix();
     }
 
@@ -440,10 +850,9 @@ namespace MRAP {
         // Rim face
         setSpec(0.35f, 0.35f, 0.35f, 48.0f);
         C(0.18f, 0.18f, 0.18f);
-        GLUquadric* q = gluNewQuadric();
+        GLUquadric* q = quadric();
         glPushMatrix(); glTranslatef(0, 0, 0.02f);      gluDisk(q, 0.0, R * 0.62f, 24, 1); glPopMatrix();
         glPushMatrix(); glTranslatef(0, 0, W - 0.02f);  gluDisk(q, 0.0, R * 0.62f, 24, 1); glPopMatrix();
-        gluDeleteQuadric(q);
         glPopMatrix();
     }
 
@@ -607,8 +1016,37 @@ int   g_lastAnimMs = 0;
 const float ROAD_START_X = ROAD_X1 - 20.0f;  // near apron edge
 const float ROAD_END_X = ROAD_X0 + 20.0f;  // far left end
 
+// Simulation advances in fixed steps so a recording replays identically
+const float SIM_DT = 1.0f / 60.0f;
+const int   SIM_MAX_STEPS = 10;   // per timer callback; drop time beyond this
+int   g_simTick = 0;
+float g_simAccum = 0.0f;
+
+// ---------------- Render passes ----------------
+enum RenderPass { PASS_TERRAIN, PASS_APRON, PASS_HANGAR, PASS_MRAP, PASS_COUNT };
+const char* PASS_NAMES[PASS_COUNT] = { "terrain", "apron", "hangar", "mrap" };
+
+// Per-pass GPU-inclusive times; only measured during replay since glFinish stalls the pipeline
+bool   g_timePasses = false;
+double g_passMs[PASS_COUNT];
+std::chrono::steady_clock::time_point g_passStart;
+
+static void passBegin() {
+    if (!g_timePasses) return;
+    glFinish();
+    g_passStart = std::chrono::steady_clock::now();
+}
+
+static void passEnd(RenderPass pass) {
+    if (!g_timePasses) return;
+    glFinish();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    g_passMs[pass] = std::chrono::duration<double, std::milli>(now - g_passStart).count();
+    g_passStart = now;
+}
+
 // ---------------- Display ----------------
-void display() {
+void renderScene() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
 
@@ -616,14 +1054,25 @@ void display() {
     float cz = camDistance * cosf(angle * (float)M_PI / 180.0f);
     gluLookAt(cx, camHeight, cz, 0.0f, APRON_Y + 5.0f, 0.0f, 0.0f, 1.0f, 0.0f);
 
-    drawTerrain();        // grassy base (with mesa mountains)
+    passBegin();
+    if (g_usePackedMeshes) drawTerrainPacked(cx, cz); // grassy base (with mesa mountains)
+    else drawTerrain();
+    passEnd(PASS_TERRAIN);
     drawApronAndRoad();   // slabs on top (with polygon offset)
+    passEnd(PASS_APRON);
     drawHangarOnApron();  // hangar sitting on apron
+    passEnd(PASS_HANGAR);
 
     // Animated MRAP
     MRAP::drawAt(g_mrapX, g_mrapZ, g_mrapYaw, g_mrapScale);
+    passEnd(PASS_MRAP);
+}
 
+void display() {
+    beginFrame();
+    renderScene();
     glutSwapBuffers();
+    endFrame();
 }
 
 // ---------------- Reshape ----------------
@@ -635,13 +1084,43 @@ void reshape(int w, int h) {
     glMatrixMode(GL_MODELVIEW);
 }
 
-// ---------------- Vehicle animation timer ----------------
-void driveTick(int) {
-    int ms = glutGet(GLUT_ELAPSED_TIME);
-    if (!g_lastAnimMs) g_lastAnimMs = ms;
-    float dt = (ms - g_lastAnimMs) / 1000.0f;
-    g_lastAnimMs = ms;
+// ---------------- Recording ----------------
+// Text format, one record per line:
+//   ARMYREPLAY 1
+//   I <angle> <camDistance> <camHeight> <mrapX> <reversePhase> <wheelSpin>   initial state
+//   K <tick> <key>                                                          key applied at tick
+//   T <tick> <mrapX> <reversePhase> <wheelSpin>                             state after step
+FILE* g_recordFile = nullptr;
+
+static void stopRecording() {
+    if (g_recordFile) fclose(g_recordFile);
+    g_recordFile = nullptr;
+}
+
+bool startRecording(const char* path) {
+    g_recordFile = fopen(path, "w");
+    if (!g_recordFile) {
+        printf("Cannot open replay file for writing: %s\n", path);
+        return false;
+    }
+    fprintf(g_recordFile, "ARMYREPLAY 1\n");
+    fprintf(g_recordFile, "I %.6f %.6f %.6f %.6f %d %.6f\n", angle, camDistance, camHeight,
+        g_mrapX, g_reversePhase ? 1 : 0, MRAP::g_wheelSpin);
+    atexit(stopRecording); // GLUT leaves the main loop through exit()
+    return true;
+}
 
+static void recordKey(unsigned char key) {
+    if (g_recordFile) fprintf(g_recordFile, "K %d %d\n", g_simTick, (int)key);
+}
+
+static void recordTick() {
+    if (g_recordFile) fprintf(g_recordFile, "T %d %.6f %d %.6f\n", g_simTick, g_mrapX,
+        g_reversePhase ? 1 : 0, MRAP::g_wheelSpin);
+}
+
+// ---------------- Vehicle animation timer ----------------
+void simulateStep(float dt) {
     // Move along X: reverse = toward negative; forward = toward start
     float dir = g_reversePhase ? -1.0f : +1.0f;
     g_mrapX += dir * g_mrapSpeed * dt;
@@ -664,12 +1143,30 @@ void driveTick(int) {
         g_reversePhase = true;  // reverse again
     }
 
+    ++g_simTick;
+}
+
+void driveTick(int) {
+    int ms = glutGet(GLUT_ELAPSED_TIME);
+    if (!g_lastAnimMs) g_lastAnimMs = ms;
+    g_simAccum += (ms - g_lastAnimMs) / 1000.0f;
+    g_lastAnimMs = ms;
+
+    int steps = 0;
+    while (g_simAccum >= SIM_DT && steps < SIM_MAX_STEPS) {
+        g_simAccum -= SIM_DT;
+        simulateStep(SIM_DT);
+        recordTick();
+        ++steps;
+    }
+    if (steps == SIM_MAX_STEPS) g_simAccum = 0.0f;
+
     glutPostRedisplay();
     glutTimerFunc(16, driveTick, 0); // ~60 FPS
 }
 
 // ---------------- Keyboard ----------------
-void keyboard(unsigned char key, int, int) {
+void applyKey(unsigned char key) {
     switch (key) {
     case 'a': case 'A': angle -= 5.0f; break;
     case 'd': case 'D': angle += 5.0f; break;
@@ -677,23 +1174,531 @@ void keyboard(unsigned char key, int, int) {
     case 's': case 'S': camDistance += 20.0f; break;
     case 'q': case 'Q': camHeight += 10.0f; break;
     case 'e': case 'E': camHeight -= 10.0f; break;
+    case 'p': case 'P':
+        g_usePackedMeshes = !g_usePackedMeshes;
+        printf("Static meshes: %s\n", g_usePackedMeshes ? "packed" : "full precision");
+        break;
     }
+}
+
+void keyboard(unsigned char key, int, int) {
+    recordKey(key);
+    applyKey(key);
     glutPostRedisplay();
 }
 
+// ---------------- Replay ----------------
+// Plays a recording at a fixed resolution into an offscreen framebuffer object,
+// reads every captured frame (each tick unless --capture-every is given) back
+// and checks it against golden PPM images, then compares mean per-pass times
+// with a baseline file. Goldens are only written with --update or into a
+// directory without the set (its first frame missing); a baseline only with
+// --update or when absent. Missing or unreadable files are failures otherwise.
+const int    REPLAY_W = 640;
+const int    REPLAY_H = 400;
+const int    REPLAY_WARMUP_FRAMES = 5;         // rendered and discarded first (texture upload, lazy init)
+const int    REPLAY_PIXEL_TOLERANCE = 8;       // per channel, 0..255
+const double REPLAY_MAX_DIFF_FRACTION = 0.005; // of pixels above tolerance
+const float  REPLAY_STATE_TOLERANCE = 1e-3f;
+const double PERF_MIN_DELTA_MS = 0.1;          // ignore noise on very cheap passes
+
+// GL_EXT_framebuffer_object entry points, loaded at runtime (GL 1.1 headers on Windows lack them)
+#ifndef GL_FRAMEBUFFER_EXT
+#define GL_FRAMEBUFFER_EXT              0x8D40
+#define GL_RENDERBUFFER_EXT             0x8D41
+#define GL_COLOR_ATTACHMENT0_EXT        0x8CE0
+#define GL_DEPTH_ATTACHMENT_EXT         0x8D00
+#define GL_FRAMEBUFFER_COMPLETE_EXT     0x8CD5
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24            0x81A6
+#endif
+
+typedef void (APIENTRY* GenFramebuffersFn)(GLsizei, GLuint*);
+typedef void (APIENTRY* BindFramebufferFn)(GLenum, GLuint);
+typedef void (APIENTRY* GenRenderbuffersFn)(GLsizei, GLuint*);
+typedef void (APIENTRY* BindRenderbufferFn)(GLenum, GLuint);
+typedef void (APIENTRY* RenderbufferStorageFn)(GLenum, GLenum, GLsizei, GLsizei);
+typedef void (APIENTRY* FramebufferRenderbufferFn)(GLenum, GLenum, GLenum, GLuint);
+typedef GLenum (APIENTRY* CheckFramebufferStatusFn)(GLenum);
+
+static void* glProc(const char* name) {
+#ifdef _WIN32
+    return (void*)wglGetProcAddress(name);
+#else
+    return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+}
+
+// Color + depth renderbuffers, so captured pixels do not depend on the window being visible
+static bool createOffscreenTarget(int w, int h) {
+    const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+    if (!ext || !strstr(ext, "GL_EXT_framebuffer_object")) {
+        printf("Replay needs GL_EXT_framebuffer_object for offscreen rendering\n");
+        return false;
+    }
+
+    GenFramebuffersFn genFramebuffers = (GenFramebuffersFn)glProc("glGenFramebuffersEXT");
+    BindFramebufferFn bindFramebuffer = (BindFramebufferFn)glProc("glBindFramebufferEXT");
+    GenRenderbuffersFn genRenderbuffers = (GenRenderbuffersFn)glProc("glGenRenderbuffersEXT");
+    BindRenderbufferFn bindRenderbuffer = (BindRenderbufferFn)glProc("glBindRenderbufferEXT");
+    RenderbufferStorageFn renderbufferStorage = (RenderbufferStorageFn)glProc("glRenderbufferStorageEXT");
+    FramebufferRenderbufferFn framebufferRenderbuffer = (FramebufferRenderbufferFn)glProc("glFramebufferRenderbufferEXT");
+    CheckFramebufferStatusFn checkFramebufferStatus = (CheckFramebufferStatusFn)glProc("glCheckFramebufferStatusEXT");
+    if (!genFramebuffers || !bindFramebuffer || !genRenderbuffers || !bindRenderbuffer
+        || !renderbufferStorage || !framebufferRenderbuffer || !checkFramebufferStatus) {
+        printf("Cannot load GL_EXT_framebuffer_object entry points\n");
+        return false;
+    }
+
+    GLuint fbo, rb[2];
+    genFramebuffers(1, &fbo);
+    bindFramebuffer(GL_FRAMEBUFFER_EXT, fbo);
+    genRenderbuffers(2, rb);
+    bindRenderbuffer(GL_RENDERBUFFER_EXT, rb[0]);
+    renderbufferStorage(GL_RENDERBUFFER_EXT, GL_RGBA8, w, h);
+    framebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, rb[0]);
+    bindRenderbuffer(GL_RENDERBUFFER_EXT, rb[1]);
+    renderbufferStorage(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT24, w, h);
+    framebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, rb[1]);
+
+    if (checkFramebufferStatus(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT) {
+        printf("Replay framebuffer is incomplete\n");
+        return false;
+    }
+    glDrawBuffer(GL_COLOR_ATTACHMENT0_EXT);
+    glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+    return true;
+}
+
+struct ReplayKey { int tick; unsigned char key; };
+struct ReplayState { int tick; float mrapX; bool reversePhase; float wheelSpin; };
+
+struct ReplaySession {
+    std::vector<ReplayKey> keys;
+    std::vector<ReplayState> states;
+    int lastTick;
+    size_t nextKey;
+    size_t nextState;
+
+    const char* goldenDir;
+    const char* baselinePath;
+    bool updateGolden;
+    double perfThreshold;
+    int captureEvery;                    // ticks between captured frames
+    bool comparePaths;                   // also diff packed against full-precision meshes
+
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> golden;
+    std::vector<unsigned char> otherPath;
+    double passTotalMs[PASS_COUNT];
+    bool writeGoldens;                   // --update, or no golden set in goldenDir yet
+    bool warmedUp;
+    int framesTimed;
+    int framesCompared;
+    int goldensWritten;
+    int pathFramesCompared;
+    double pathMaxFraction;
+    int pathMaxDiff;
+    int failures;
+};
+
+ReplaySession g_replay;
+
+static bool loadReplay(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("Cannot open replay file: %s\n", path);
+        return false;
+    }
+
+    char line[256];
+    int version = 0;
+    if (!fgets(line, sizeof(line), f) || sscanf(line, "ARMYREPLAY %d", &version) != 1 || version != 1) {
+        printf("Not a replay file: %s\n", path);
+        fclose(f);
+        return false;
+    }
+
+    g_replay.lastTick = 0;
+    while (fgets(line, sizeof(line), f)) {
+        int tick, flag, key;
+        float a, b, c, x, spin;
+        if (sscanf(line, "I %f %f %f %f %d %f", &a, &b, &c, &x, &flag, &spin) == 6) {
+            angle = a; camDistance = b; camHeight = c;
+            g_mrapX = x; g_reversePhase = flag != 0; MRAP::g_wheelSpin = spin;
+        }
+        else if (sscanf(line, "K %d %d", &tick, &key) == 2) {
+            ReplayKey k = { tick, (unsigned char)key };
+            g_replay.keys.push_back(k);
+            if (tick > g_replay.lastTick) g_replay.lastTick = tick;
+        }
+        else if (sscanf(line, "T %d %f %d %f", &tick, &x, &flag, &spin) == 4) {
+            ReplayState st = { tick, x, flag != 0, spin };
+            g_replay.states.push_back(st);
+            if (tick > g_replay.lastTick) g_replay.lastTick = tick;
+        }
+    }
+    fclose(f);
+
+    printf("Replay %s: %d ticks, %d key events\n", path, g_replay.lastTick, (int)g_replay.keys.size());
+    return true;
+}
+
+static bool fileExists(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != nullptr;
+}
+
+static void goldenPath(char* out, size_t size, int tick) {
+    snprintf(out, size, "%s/frame_%06d.ppm", g_replay.goldenDir, tick);
+}
+
+static bool readPPM(const char* path, std::vector<unsigned char>& out, int w, int h) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    int fw = 0, fh = 0, maxv = 0;
+    bool ok = fscanf(f, "P6 %d %d %d", &fw, &fh, &maxv) == 3 && fw == w && fh == h && maxv == 255
+        && fgetc(f) != EOF;
+    out.resize((size_t)w * h * 3);
+    ok = ok && fread(&out[0], 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+static bool writePPM(const char* path, const std::vector<unsigned char>& data, int w, int h) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+    fclose(f);
+    return ok;
+}
+
+// Fraction of pixels whose largest channel difference exceeds REPLAY_PIXEL_TOLERANCE
+static double diffImages(const std::vector<unsigned char>& a, const std::vector<unsigned char>& b, int& maxDiff) {
+    size_t differing = 0;
+    maxDiff = 0;
+    for (size_t p = 0; p < a.size(); p += 3) {
+        bool differs = false;
+        for (int c = 0; c < 3; ++c) {
+            int diff = abs((int)a[p + c] - (int)b[p + c]);
+            if (diff > maxDiff) maxDiff = diff;
+            if (diff > REPLAY_PIXEL_TOLERANCE) differs = true;
+        }
+        if (differs) ++differing;
+    }
+    return (double)differing / ((size_t)REPLAY_W * REPLAY_H);
+}
+
+static void readFrame(std::vector<unsigned char>& out) {
+    // glReadPixels is bottom-up; PPM rows are stored in that order and compared as-is
+    glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, REPLAY_W, REPLAY_H, GL_RGB, GL_UNSIGNED_BYTE, &out[0]);
+}
+
+static void compareFrame() {
+    if (!g_replay.goldenDir) return;
+
+    char path[512];
+    goldenPath(path, sizeof(path), g_simTick);
+
+    bool exists = fileExists(path);
+    if (g_replay.writeGoldens) {
+        if (exists && !g_replay.updateGolden) {
+            printf("FAIL image tick %d: %s already exists in a new golden set; rerun with --update\n", g_simTick, path);
+            ++g_replay.failures;
+        }
+        else if (writePPM(path, g_replay.pixels, REPLAY_W, REPLAY_H)) {
+            ++g_replay.goldensWritten;
+        }
+        else {
+            printf("Cannot write golden image %s\n", path);
+            ++g_replay.failures;
+        }
+        return;
+    }
+
+    if (!exists) {
+        printf("FAIL image tick %d: golden %s is missing\n", g_simTick, path);
+        ++g_replay.failures;
+        return;
+    }
+
+    if (!readPPM(path, g_replay.golden, REPLAY_W, REPLAY_H)) {
+        printf("FAIL image tick %d: golden %s is unreadable or not %dx%d\n", g_simTick, path, REPLAY_W, REPLAY_H);
+        ++g_replay.failures;
+        return;
+    }
+
+    int maxDiff = 0;
+    double fraction = diffImages(g_replay.pixels, g_replay.golden, maxDiff);
+    ++g_replay.framesCompared;
+
+    if (fraction > REPLAY_MAX_DIFF_FRACTION) {
+        printf("FAIL image tick %d: %.3f%% pixels differ (max channel diff %d)\n",
+            g_simTick, fraction * 100.0, maxDiff);
+        ++g_replay.failures;
+    }
+}
+
+static void checkPerformance() {
+    if (!g_replay.framesTimed) {
+        printf("FAIL perf: no frames were timed\n");
+        ++g_replay.failures;
+        return;
+    }
+
+    double mean[PASS_COUNT];
+    for (int p = 0; p < PASS_COUNT; ++p) {
+        mean[p] = g_replay.passTotalMs[p] / g_replay.framesTimed;
+        printf("  %-8s %8.3f ms\n", PASS_NAMES[p], mean[p]);
+    }
+    if (!g_replay.baselinePath) return;
+
+    FILE* existing = fopen(g_replay.baselinePath, "r");
+    if (!existing || g_replay.updateGolden) {
+        if (existing) fclose(existing);
+        FILE* f = fopen(g_replay.baselinePath, "w");
+        if (!f) {
+            printf("Cannot write baseline %s\n", g_replay.baselinePath);
+            ++g_replay.failures;
+            return;
+        }
+        for (int p = 0; p < PASS_COUNT; ++p) fprintf(f, "%s %.4f\n", PASS_NAMES[p], mean[p]);
+        fclose(f);
+        printf("Wrote baseline %s\n", g_replay.baselinePath);
+        return;
+    }
+
+    double base[PASS_COUNT];
+    char name[32];
+    for (int p = 0; p < PASS_COUNT; ++p) {
+        if (fscanf(existing, "%31s %lf", name, &base[p]) != 2 || strcmp(name, PASS_NAMES[p]) != 0) {
+            printf("FAIL perf: baseline %s is malformed (expected pass '%s')\n", g_replay.baselinePath, PASS_NAMES[p]);
+            ++g_replay.failures;
+            fclose(existing);
+            return;
+        }
+    }
+    fclose(existing);
+
+    for (int p = 0; p < PASS_COUNT; ++p) {
+        double delta = mean[p] - base[p];
+        if (delta > PERF_MIN_DELTA_MS && delta > base[p] * g_replay.perfThreshold) {
+            printf("FAIL perf %s: %.3f ms vs baseline %.3f ms (+%.0f%%)\n",
+                PASS_NAMES[p], mean[p], base[p], base[p] > 0.0 ? delta / base[p] * 100.0 : 0.0);
+            ++g_replay.failures;
+        }
+    }
+}
+
+// Renders the same frame again with the other static-mesh path and diffs the two,
+// so quantization error is measured in pixels rather than only in height units
+static void comparePackedPaths() {
+    bool timing = g_timePasses;
+    g_timePasses = false;
+    g_usePackedMeshes = !g_usePackedMeshes;
+    beginFrame();
+    renderScene();
+    endFrame();
+    readFrame(g_replay.otherPath);
+    g_usePackedMeshes = !g_usePackedMeshes;
+    g_timePasses = timing;
+
+    int maxDiff = 0;
+    double fraction = diffImages(g_replay.pixels, g_replay.otherPath, maxDiff);
+    ++g_replay.pathFramesCompared;
+    if (fraction > g_replay.pathMaxFraction) g_replay.pathMaxFraction = fraction;
+    if (maxDiff > g_replay.pathMaxDiff) g_replay.pathMaxDiff = maxDiff;
+    if (fraction > REPLAY_MAX_DIFF_FRACTION) {
+        printf("FAIL packed vs full precision tick %d: %.3f%% pixels differ (max channel diff %d)\n",
+            g_simTick, fraction * 100.0, maxDiff);
+        ++g_replay.failures;
+    }
+}
+
+static void replayCaptureFrame() {
+    beginFrame();
+    renderScene();
+    endFrame();
+
+    for (int p = 0; p < PASS_COUNT; ++p) g_replay.passTotalMs[p] += g_passMs[p];
+    ++g_replay.framesTimed;
+
+    readFrame(g_replay.pixels);
+    compareFrame();
+    if (g_replay.comparePaths) comparePackedPaths();
+}
+
+static void applyReplayKeys() {
+    while (g_replay.nextKey < g_replay.keys.size() && g_replay.keys[g_replay.nextKey].tick <= g_simTick) {
+        applyKey(g_replay.keys[g_replay.nextKey].key);
+        ++g_replay.nextKey;
+    }
+}
+
+// Idle callback: advance the simulation to the next capture tick, then render and compare
+void replayStep() {
+    // Warm-up frames pay for texture upload and lazy initialization; keep them out of every check
+    if (!g_replay.warmedUp) {
+        int paths = g_replay.comparePaths ? 2 : 1;
+        g_steadyStateFrom = g_frameNumber + paths * REPLAY_WARMUP_FRAMES;
+        for (int path = 0; path < paths; ++path) {
+            for (int i = 0; i < REPLAY_WARMUP_FRAMES; ++i) {
+                beginFrame();
+                renderScene();
+                endFrame();
+            }
+            g_usePackedMeshes = !g_usePackedMeshes;
+        }
+        if (paths == 1) g_usePackedMeshes = !g_usePackedMeshes;
+        g_replay.warmedUp = true;
+    }
+
+    do {
+        applyReplayKeys();
+        if (g_simTick >= g_replay.lastTick) break;
+        simulateStep(SIM_DT);
+
+        while (g_replay.nextState < g_replay.states.size() && g_replay.states[g_replay.nextState].tick < g_simTick)
+            ++g_replay.nextState;
+        if (g_replay.nextState < g_replay.states.size() && g_replay.states[g_replay.nextState].tick == g_simTick) {
+            const ReplayState& st = g_replay.states[g_replay.nextState];
+            if (fabsf(st.mrapX - g_mrapX) > REPLAY_STATE_TOLERANCE || st.reversePhase != g_reversePhase
+                || fabsf(st.wheelSpin - MRAP::g_wheelSpin) > REPLAY_STATE_TOLERANCE) {
+                printf("FAIL state tick %d: mrapX %.4f reversePhase %d wheelSpin %.4f"
+                    " (recorded %.4f %d %.4f)\n", g_simTick, g_mrapX, g_reversePhase ? 1 : 0,
+                    MRAP::g_wheelSpin, st.mrapX, st.reversePhase ? 1 : 0, st.wheelSpin);
+                ++g_replay.failures;
+            }
+        }
+    } while (g_simTick % g_replay.captureEvery != 0);
+
+    replayCaptureFrame();
+
+    if (g_simTick >= g_replay.lastTick) {
+        printf("Replay finished: %d frames compared, %d goldens written, mean pass times over %d frames:\n",
+            g_replay.framesCompared, g_replay.goldensWritten, g_replay.framesTimed);
+        checkPerformance();
+        if (g_steadyAllocFrames) {
+            printf("FAIL alloc: %u steady-state frames made heap allocations\n", g_steadyAllocFrames);
+            ++g_replay.failures;
+        }
+        if (g_replay.comparePaths)
+            printf("Packed vs full precision over %d frames: worst %.3f%% pixels differ, max channel diff %d\n",
+                g_replay.pathFramesCompared, g_replay.pathMaxFraction * 100.0, g_replay.pathMaxDiff);
+        if (g_replay.failures) {
+            printf("REPLAY FAILED (%d failures)\n", g_replay.failures);
+            exit(1);
+        }
+        // Frames not checked against an existing golden: not a pass (new set, --update, no --golden)
+        if (!g_replay.framesCompared || g_replay.goldensWritten) {
+            printf("REPLAY INCOMPLETE: %d frames compared, %d goldens written\n",
+                g_replay.framesCompared, g_replay.goldensWritten);
+            exit(2);
+        }
+        printf("REPLAY PASSED\n");
+        exit(0);
+    }
+}
+
+bool startReplay(const char* path, const char* goldenDir, const char* baselinePath,
+    bool updateGolden, double perfThreshold, int captureEvery, bool comparePaths) {
+    g_replay.nextKey = g_replay.nextState = 0;
+    g_replay.goldenDir = goldenDir;
+    g_replay.baselinePath = baselinePath;
+    g_replay.updateGolden = updateGolden;
+    g_replay.perfThreshold = perfThreshold;
+    g_replay.captureEvery = captureEvery > 0 ? captureEvery : 1;
+    g_replay.comparePaths = comparePaths;
+    g_replay.pathFramesCompared = g_replay.pathMaxDiff = 0;
+    g_replay.pathMaxFraction = 0.0;
+    g_replay.warmedUp = false;
+    g_replay.framesTimed = 0;
+    g_replay.framesCompared = g_replay.goldensWritten = g_replay.failures = 0;
+    for (int p = 0; p < PASS_COUNT; ++p) g_replay.passTotalMs[p] = 0.0;
+    g_replay.pixels.resize((size_t)REPLAY_W * REPLAY_H * 3);
+    g_replay.otherPath.resize(g_replay.pixels.size());
+
+    if (!loadReplay(path)) return false;
+
+    // The set counts as absent when its first captured frame is missing
+    g_replay.writeGoldens = updateGolden;
+    if (goldenDir && !updateGolden) {
+        char path0[512];
+        int firstTick = g_replay.lastTick < g_replay.captureEvery ? g_replay.lastTick : g_replay.captureEvery;
+        goldenPath(path0, sizeof(path0), firstTick);
+        g_replay.writeGoldens = !fileExists(path0);
+        if (g_replay.writeGoldens) printf("No golden set in %s; writing one\n", goldenDir);
+    }
+
+    if (!createOffscreenTarget(REPLAY_W, REPLAY_H)) return false;
+
+    g_simTick = 0;
+    g_timePasses = true;
+    reshape(REPLAY_W, REPLAY_H);
+    return true;
+}
+
 // ---------------- Main ----------------
+// Usage:
+//   S20317                                   interactive
+//   S20317 --record <file>                   interactive, record input + simulation
+//   S20317 --replay <file> [--golden <dir>] [--baseline <file>]
+//          [--perf-threshold <fraction>] [--capture-every <ticks>] [--compare-paths] [--update]
+//   replay exit status: 0 passed, 1 failed, 2 incomplete (goldens written or nothing compared)
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    atexit(reportFrameAllocs);
+
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* goldenDir = nullptr;
+    const char* baselinePath = nullptr;
+    bool updateGolden = false;
+    double perfThreshold = 0.15;
+    int captureEvery = 1;
+    bool comparePaths = false;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--record") && hasValue) recordPath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && hasValue) replayPath = argv[++i];
+        else if (!strcmp(argv[i], "--golden") && hasValue) goldenDir = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && hasValue) baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--perf-threshold") && hasValue) perfThreshold = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--capture-every") && hasValue) captureEvery = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--compare-paths")) comparePaths = true;
+        else if (!strcmp(argv[i], "--update")) updateGolden = true;
+        else printf("Ignoring argument: %s\n", argv[i]);
+    }
+
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-    glutInitWindowSize(1280, 800);
+    if (replayPath) glutInitWindowSize(REPLAY_W, REPLAY_H);
+    else glutInitWindowSize(1280, 800);
     glutCreateWindow("3D Military Base");
 
     init();
+    buildTerrainMesh();
+    buildHangarMeshes();
 
     // Initialize MRAP start position and animation clock
     g_mrapX = ROAD_START_X;   // start near apron edge, on road center
     g_lastAnimMs = glutGet(GLUT_ELAPSED_TIME);
 
+    if (replayPath) {
+        if (!startReplay(replayPath, goldenDir, baselinePath, updateGolden, perfThreshold, captureEvery, comparePaths)) return 1;
+        glutDisplayFunc([]() {}); // frames are rendered offscreen by replayStep
+        glutReshapeFunc([](int, int) {}); // keep the framebuffer-sized viewport
+        glutIdleFunc(replayStep);
+        glutMainLoop();
+        return 0;
+    }
+
+    if (recordPath && !startRecording(recordPath)) return 1;
+
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutKeyboardFunc(keyboard);